@@ -6,6 +6,19 @@
 #include <limits>
 #include <ctime>
 #include <cstring>
+#include <cstdio>
+#include <numeric>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <charconv>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <cctype>
+#include <atomic>
+#include <sstream>
 using namespace std;
 
 // Safely clears wrong user input
@@ -14,6 +27,131 @@ void clearInput() {
     cin.ignore(numeric_limits<streamsize>::max(), '\n');
 }
 
+// ======================== THREAD HELPERS ========================
+// Number of threads parallelFor() uses for n items, giving every
+// thread at least minPerWorker items
+size_t workerCount(size_t n, size_t minPerWorker = 1) {
+    size_t hw = max(1u, thread::hardware_concurrency());
+    return max((size_t)1, min(hw, n / max((size_t)1, minPerWorker)));
+}
+
+// Splits [0, n) into one contiguous range per worker and calls
+// fn(begin, end, worker) on each. Worker 0 runs on the calling thread.
+template <typename Fn>
+void parallelFor(size_t n, Fn fn, size_t minPerWorker = 1) {
+    size_t workers = workerCount(n, minPerWorker);
+    vector<thread> pool;
+    for (size_t w = 1; w < workers; w++)
+        pool.emplace_back(fn, n * w / workers, n * (w + 1) / workers, w);
+    fn(0, n / workers, 0);
+    for (thread& t : pool) t.join();
+}
+
+// ======================== DATE HELPERS ========================
+// Dates are handled as day numbers (days since 1970-01-01)
+// so that recurring rules and projections need no calendar objects.
+
+// Converts a calendar date to a day number
+long long daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Converts a day number back to a calendar date
+void civilFromDays(long long z, int& y, int& m, int& d) {
+    z += 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    y = (int)(yoe + era * 400 + (m <= 2));
+}
+
+bool isLeapYear(int y) {
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+int daysInMonth(int y, int m) {
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (m == 2 && isLeapYear(y)) ? 29 : days[m - 1];
+}
+
+// Parses "YYYY-MM-DD" (anything after the date is ignored), false if malformed
+bool tryParseDay(const string& s, long long& day) {
+    int y, m, d;
+    if (sscanf(s.c_str(), "%d-%d-%d", &y, &m, &d) != 3 ||
+        m < 1 || m > 12 || d < 1 || d > daysInMonth(y, m))
+        return false;
+    day = daysFromCivil(y, m, d);
+    return true;
+}
+
+// Same as tryParseDay() but throws on bad input
+long long parseDay(const string& s) {
+    long long day;
+    if (!tryParseDay(s, day))
+        throw invalid_argument("Invalid date (use YYYY-MM-DD): " + s);
+    return day;
+}
+
+// Reads `count` digits at s[at], false if any is not a digit
+bool readDigits(const string& s, size_t at, int count, int& value) {
+    value = 0;
+    for (int i = 0; i < count; i++) {
+        char c = s[at + i];
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+// Parses "YYYY-MM-DD[ HH:MM[:SS]]" into seconds since 1970 (no time = midnight)
+bool tryParseTimestamp(const string& s, long long& secs) {
+    // Fast path for the "YYYY-MM-DD HH:MM:SS" stamps written by this program
+    int y, m, d, h, mi, sec;
+    if (s.size() == 19 && s[4] == '-' && s[7] == '-' && s[10] == ' ' && s[13] == ':' && s[16] == ':' &&
+        readDigits(s, 0, 4, y) && readDigits(s, 5, 2, m) && readDigits(s, 8, 2, d) &&
+        readDigits(s, 11, 2, h) && readDigits(s, 14, 2, mi) && readDigits(s, 17, 2, sec) &&
+        m >= 1 && m <= 12 && d >= 1 && d <= daysInMonth(y, m)) {
+        secs = daysFromCivil(y, m, d) * 86400 + h * 3600 + mi * 60 + sec;
+        return true;
+    }
+
+    long long day;
+    if (!tryParseDay(s, day)) return false;
+
+    h = mi = sec = 0;
+    size_t space = s.find(' ');
+    if (space != string::npos &&
+        sscanf(s.c_str() + space + 1, "%d:%d:%d", &h, &mi, &sec) < 2)
+        h = mi = sec = 0;
+    secs = day * 86400 + h * 3600 + mi * 60 + sec;
+    return true;
+}
+
+// Formats a day number as "YYYY-MM-DD"
+string formatDay(long long day) {
+    int y, m, d;
+    civilFromDays(day, y, m, d);
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%04d-%02d-%02d", y, m, d);
+    return string(buf);
+}
+
+// Today's date as a day number (local time)
+long long todayDay() {
+    time_t now = time(0);
+    tm* lt = localtime(&now);
+    return daysFromCivil(lt->tm_year + 1900, lt->tm_mon + 1, lt->tm_mday);
+}
+
 // ======================== BASE CLASS ========================
 // Parent class for all transactions (Income / Expense)
 class Transaction {
@@ -40,16 +178,16 @@ public:
     }
 
     // Getters
-    string getType() const { 
+    const string& getType() const { 
         return type; 
     }
     double getAmount() const { 
         return amount; 
     }
-    string getDateTime() const { 
+    const string& getDateTime() const { 
         return dateTime; 
     }
-    string getNote() const { 
+    const string& getNote() const { 
         return note; 
     }
 };
@@ -77,16 +215,659 @@ public:
     }
 };
 
+// ======================== RECURRING RULES ========================
+// A rule describes a repeating Income / Expense (salary, subscription...).
+// Occurrences are generated on demand and never stored as records.
+class RecurringRule {
+protected:
+    string type;        // Income / Expense
+    double amount;      // Amount of each occurrence
+    string period;      // daily / weekly / monthly / yearly
+    string note;        // Optional note
+    long long startDay; // First occurrence
+    long long endDay;   // Last possible occurrence (NO_END if open-ended)
+
+public:
+    static const long long NO_END = numeric_limits<long long>::max();
+
+    RecurringRule(string t, double a, string p, string nt, long long start, long long end = NO_END) {
+        if (t != "Income" && t != "Expense")
+            throw invalid_argument("Rule type must be Income or Expense");
+        if (a <= 0)
+            throw invalid_argument("Amount must be greater than 0");
+        if (p != "daily" && p != "weekly" && p != "monthly" && p != "yearly")
+            throw invalid_argument("Period must be daily, weekly, monthly or yearly");
+        if (end < start)
+            throw invalid_argument("End date is before start date");
+
+        type = t;
+        amount = a;
+        period = p;
+        note = nt;
+        startDay = start;
+        endDay = end;
+    }
+
+    // Calls fn(day) for every occurrence inside [from, to]
+    template <typename Fn>
+    void forEachOccurrence(long long from, long long to, Fn fn) const {
+        from = max(from, startDay);
+        to = min(to, endDay);
+        if (from > to) return;
+
+        if (period == "daily" || period == "weekly") {
+            long long step = (period == "daily") ? 1 : 7;
+            long long first = startDay + (from - startDay + step - 1) / step * step;
+            for (long long day = first; day <= to; day += step)
+                fn(day);
+            return;
+        }
+
+        // Monthly / yearly: keep the start day-of-month, clamped to short months
+        int sy, sm, sd, fy, fm, fd;
+        civilFromDays(startDay, sy, sm, sd);
+        civilFromDays(from, fy, fm, fd);
+        int step = (period == "monthly") ? 1 : 12;
+        long long skip = ((fy - sy) * 12LL + (fm - sm)) / step - 1;
+        for (long long n = max(0LL, skip);; n++) {
+            long long months = (sm - 1) + n * step;
+            int y = sy + (int)(months / 12);
+            int m = (int)(months % 12) + 1;
+            long long day = daysFromCivil(y, m, min(sd, daysInMonth(y, m)));
+            if (day > to) break;
+            if (day >= from) fn(day);
+        }
+    }
+
+    // Displays rule details
+    void display() const {
+        cout << type << " : " << amount << " " << period
+             << "  |  " << formatDay(startDay) << " -> "
+             << (endDay == NO_END ? string("open") : formatDay(endDay))
+             << "  |  Note: " << note << endl;
+    }
+
+    // Getters
+    string getType() const {
+        return type;
+    }
+    double getAmount() const {
+        return amount;
+    }
+    string getPeriod() const {
+        return period;
+    }
+    string getNote() const {
+        return note;
+    }
+    long long getStartDay() const {
+        return startDay;
+    }
+    long long getEndDay() const {
+        return endDay;
+    }
+};
+
+// ======================== CSV HELPERS ========================
+// Appends one RFC-4180 field, quoting only when needed
+void appendCsvField(string& out, const string& v) {
+    if (v.find_first_of(",\"\r\n") == string::npos) {
+        out += v;
+        return;
+    }
+    out += '"';
+    for (char c : v) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+// Appends a double in its shortest round-trip form (no iostreams)
+void appendDouble(string& out, double v) {
+    char buf[32];
+    to_chars_result r = to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, r.ptr);
+}
+
+// Splits a line on commas with no quote handling (pre-quoting ledger files)
+void splitLegacyCsv(string line, vector<string>& fields) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    fields.clear();
+    size_t start = 0;
+    for (size_t comma; (comma = line.find(',', start)) != string::npos; start = comma + 1)
+        fields.push_back(line.substr(start, comma - start));
+    fields.push_back(line.substr(start));
+}
+
+// Reads one RFC-4180 record (quoted fields may contain commas / newlines).
+// A closing quote must be followed by ',' or the line end, and a quote left
+// open is only continued onto later lines if it closes within a few lines.
+// Otherwise the line is an old unquoted record that happens to contain a
+// '"', and it is split as plain text.
+bool readCsvRecord(istream& in, vector<string>& fields) {
+    const int MAX_CONTINUATION_LINES = 64;
+
+    fields.clear();
+    string first;
+    if (!getline(in, first)) return false;
+    streampos afterFirst = -1;      // Only needed if we read past the first line
+
+    string line = first, field;
+    bool quoted = false, legacy = false;
+    int continued = 0;
+    for (size_t i = 0;; i++) {
+        if (i == line.size()) {
+            if (!quoted) {
+                // Real end of record: a CR here is the CRLF line ending
+                if (!line.empty() && line.back() == '\r') field.pop_back();
+                break;
+            }
+            // Quoted field continues; a CR before the break stays in it
+            if (continued == 0) afterFirst = in.tellg();
+            if (continued == MAX_CONTINUATION_LINES || !getline(in, line)) {
+                legacy = true;
+                break;
+            }
+            continued++;
+            field += '\n';
+            i = (size_t)-1;
+            continue;
+        }
+        char c = line[i];
+        if (quoted) {
+            if (c != '"') field += c;
+            else if (i + 1 < line.size() && line[i + 1] == '"') field += line[++i];
+            else {
+                quoted = false;
+                // Anything else after the closing quote means this was
+                // never a quoted field
+                size_t rest = line.size() - i - 1;
+                if (rest && line[i + 1] != ',' && !(rest == 1 && line[i + 1] == '\r')) {
+                    legacy = true;
+                    break;
+                }
+            }
+        }
+        else if (c == '"' && field.empty()) quoted = true;
+        else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+        }
+        else field += c;
+    }
+    if (legacy) {
+        // Unterminated or malformed: re-read from the line after the first
+        if (continued > 0 && afterFirst != streampos(-1)) {
+            in.clear();
+            in.seekg(afterFirst);
+        }
+        splitLegacyCsv(first, fields);
+        return true;
+    }
+    fields.push_back(field);
+    return true;
+}
+
+// ======================== EXPORT ========================
+enum class ExportFormat { CSV, JSONL, COLUMNAR };
+
+// Rows to export; empty type / default days = no restriction
+struct ExportFilter {
+    long long fromDay = numeric_limits<long long>::min();
+    long long toDay = numeric_limits<long long>::max();
+    string type;
+};
+
+// Streams the ledger to CSV, JSON Lines or a columnar binary file.
+// Text formats are produced in blocks by several threads and written
+// in order, so memory stays bounded and the disk stays busy.
+class Exporter {
+private:
+    const vector<Transaction*>& records;
+
+    static const size_t BLOCK_ROWS = 65536;
+
+    static void appendJsonString(string& out, const string& v) {
+        out += '"';
+        for (unsigned char c : v) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += (char)c;
+            }
+            else if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else out += (char)c;
+        }
+        out += '"';
+    }
+
+    // Formats rows[begin, end) into out
+    void formatBlock(ExportFormat fmt, const vector<size_t>& rows,
+                     size_t begin, size_t end, string& out) const {
+        out.clear();
+        for (size_t i = begin; i < end; i++) {
+            const Transaction* t = records[rows[i]];
+            if (fmt == ExportFormat::CSV) {
+                appendCsvField(out, t->getType());
+                out += ',';
+                appendDouble(out, t->getAmount());
+                out += ',';
+                appendCsvField(out, t->getDateTime());
+                out += ',';
+                appendCsvField(out, t->getNote());
+                out += '\n';
+            }
+            else {
+                out += "{\"type\":";
+                appendJsonString(out, t->getType());
+                out += ",\"amount\":";
+                appendDouble(out, t->getAmount());
+                out += ",\"dateTime\":";
+                appendJsonString(out, t->getDateTime());
+                out += ",\"note\":";
+                appendJsonString(out, t->getNote());
+                out += "}\n";
+            }
+        }
+    }
+
+    void writeText(ofstream& file, ExportFormat fmt, const vector<size_t>& rows) const {
+        size_t blocks = (rows.size() + BLOCK_ROWS - 1) / BLOCK_ROWS;
+        size_t perWave = workerCount(blocks);
+        vector<string> buffers[2] = {vector<string>(perWave), vector<string>(perWave)};
+        thread writer;
+
+        // Each wave formats one block per worker while the writer thread
+        // is still flushing the previous wave, in order
+        for (size_t first = 0, wave = 0; first < blocks; first += perWave, wave++) {
+            vector<string>& bufs = buffers[wave % 2];
+            size_t count = min(perWave, blocks - first);
+            parallelFor(count, [&](size_t begin, size_t end, size_t) {
+                for (size_t b = begin; b < end; b++) {
+                    size_t row = (first + b) * BLOCK_ROWS;
+                    formatBlock(fmt, rows, row, min(rows.size(), row + BLOCK_ROWS), bufs[b]);
+                }
+            });
+
+            if (writer.joinable()) writer.join();
+            writer = thread([&file, &bufs, count] {
+                for (size_t b = 0; b < count; b++)
+                    file.write(bufs[b].data(), bufs[b].size());
+            });
+        }
+        if (writer.joinable()) writer.join();
+    }
+
+    // Layout: "FINCOL1\0", uint64 rows, then per column:
+    //   type   uint8[rows]   (1 = Income, 2 = Expense)
+    //   amount double[rows]
+    //   dateTime, note: uint64 offsets[rows + 1] followed by the bytes
+    void writeColumnar(ofstream& file, const vector<size_t>& rows) const {
+        uint64_t n = rows.size();
+        file.write("FINCOL1\0", 8);
+        file.write((const char*)&n, sizeof(n));
+
+        string buf;
+        auto flush = [&](bool force) {
+            if (force || buf.size() >= (1 << 20)) {
+                file.write(buf.data(), buf.size());
+                buf.clear();
+            }
+        };
+
+        for (size_t r : rows) {
+            buf += (char)(records[r]->getType() == "Income" ? 1 : 2);
+            flush(false);
+        }
+        for (size_t r : rows) {
+            double a = records[r]->getAmount();
+            buf.append((const char*)&a, sizeof(a));
+            flush(false);
+        }
+
+        for (int col = 0; col < 2; col++) {
+            auto field = [&](size_t r) -> const string& {
+                return col == 0 ? records[r]->getDateTime() : records[r]->getNote();
+            };
+            uint64_t offset = 0;
+            buf.append((const char*)&offset, sizeof(offset));
+            for (size_t r : rows) {
+                offset += field(r).size();
+                buf.append((const char*)&offset, sizeof(offset));
+                flush(false);
+            }
+            for (size_t r : rows) {
+                buf += field(r);
+                flush(false);
+            }
+        }
+        flush(true);
+    }
+
+public:
+    Exporter(const vector<Transaction*>& recs) : records(recs) {}
+
+    // Indexes of all records matching the filter, in ledger order
+    vector<size_t> select(const ExportFilter& f) const {
+        bool byDate = f.fromDay != numeric_limits<long long>::min() ||
+                      f.toDay != numeric_limits<long long>::max();
+        const size_t minPerWorker = 100000;
+
+        // Each worker filters its own range; the lists are joined in order
+        vector<vector<size_t>> parts(workerCount(records.size(), minPerWorker));
+        parallelFor(records.size(), [&](size_t begin, size_t end, size_t w) {
+            for (size_t i = begin; i < end; i++) {
+                if (!f.type.empty() && records[i]->getType() != f.type)
+                    continue;
+                if (byDate) {
+                    long long secs;
+                    if (!tryParseTimestamp(records[i]->getDateTime(), secs))
+                        continue;
+                    long long day = secs / 86400 - (secs % 86400 < 0);
+                    if (day < f.fromDay || day > f.toDay)
+                        continue;
+                }
+                parts[w].push_back(i);
+            }
+        }, minPerWorker);
+
+        vector<size_t> rows;
+        for (const vector<size_t>& p : parts)
+            rows.insert(rows.end(), p.begin(), p.end());
+        return rows;
+    }
+
+    // Writes the given rows to path; returns the number of rows written
+    size_t exportTo(const string& path, ExportFormat fmt,
+                    const vector<size_t>& rows, bool csvHeader = true) const {
+        ofstream file(path, ios::binary);
+        if (!file.is_open())
+            throw runtime_error("Cannot open file: " + path);
+
+        if (fmt == ExportFormat::COLUMNAR)
+            writeColumnar(file, rows);
+        else {
+            if (fmt == ExportFormat::CSV && csvHeader)
+                file << "type,amount,dateTime,note\n";
+            writeText(file, fmt, rows);
+        }
+
+        if (!file)
+            throw runtime_error("Write failed: " + path);
+        return rows.size();
+    }
+};
+
+// ======================== COLUMN STORE ========================
+// Column-wise snapshot of the ledger, used for fast scans by queries.
+// Notes are not copied: they point into the Transaction objects.
+class LedgerColumns {
+public:
+    static const long long NO_TIME = numeric_limits<long long>::min();
+
+    vector<uint8_t> type;           // 1 = Income, 2 = Expense
+    vector<double> amount;
+    vector<long long> time;         // Seconds since 1970, NO_TIME if unparseable
+    vector<const string*> note;
+    bool timeSorted = true;         // Rows are in timestamp order
+
+    LedgerColumns() {}
+
+    explicit LedgerColumns(const vector<Transaction*>& records) {
+        size_t n = records.size();
+        type.resize(n);
+        amount.resize(n);
+        time.resize(n);
+        note.resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            type[i] = (records[i]->getType() == "Income") ? 1 : 2;
+            amount[i] = records[i]->getAmount();
+            if (!tryParseTimestamp(records[i]->getDateTime(), time[i]))
+                time[i] = NO_TIME;
+            note[i] = &records[i]->getNote();
+        }
+        timeSorted = is_sorted(time.begin(), time.end());
+    }
+
+    size_t size() const {
+        return type.size();
+    }
+
+    // First row whose time is >= t (only meaningful when timeSorted)
+    size_t lowerBound(long long t) const {
+        return lower_bound(time.begin(), time.end(), t) - time.begin();
+    }
+};
+
+// ======================== QUANTILE SKETCH ========================
+// KLL sketch: keeps a few hundred values in levels of doubling weight, so
+// median / p95 can be answered for any number of transactions with a
+// small rank error. Sketches built on different threads can be merged.
+class QuantileSketch {
+private:
+    int k;                          // Accuracy: larger = more precise
+    vector<vector<double>> levels;  // Level h items each stand for 2^h values
+    vector<size_t> caps;            // Capacity of each level
+    size_t totalCap = 0;
+    size_t stored = 0;              // Items currently held in all levels
+    size_t count = 0;               // Values added so far
+    uint64_t seed;                  // xorshift state for compaction coin flips
+
+    // Top level holds k items, each level below 2/3 of the one above
+    void updateCaps() {
+        caps.resize(levels.size());
+        totalCap = 0;
+        for (size_t h = 0; h < levels.size(); h++) {
+            double cap = k * pow(2.0 / 3.0, (double)(levels.size() - 1 - h));
+            caps[h] = max((size_t)2, (size_t)ceil(cap));
+            totalCap += caps[h];
+        }
+    }
+
+    bool coinFlip() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed & 1;
+    }
+
+    // While over budget, halves the lowest full level, promoting one of
+    // each sorted pair to the level above
+    void compress() {
+        while (stored >= totalCap) {
+            size_t h = 0;
+            while (levels[h].size() < caps[h]) h++;
+            if (h + 1 == levels.size()) {
+                levels.emplace_back();
+                updateCaps();
+            }
+
+            vector<double>& lv = levels[h];
+            sort(lv.begin(), lv.end());
+            size_t keep = lv.size() % 2;    // An odd item stays behind
+            size_t before = levels[h + 1].size();
+            for (size_t i = keep + (coinFlip() ? 1 : 0); i < lv.size(); i += 2)
+                levels[h + 1].push_back(lv[i]);
+            stored -= lv.size() - keep - (levels[h + 1].size() - before);
+            lv.resize(keep);
+        }
+    }
+
+public:
+    QuantileSketch(int accuracy = 200) {
+        // Every sketch gets its own coin-flip stream (splitmix64 of a
+        // counter), so partial sketches built on threads stay independent
+        static atomic<uint64_t> instances(0);
+        uint64_t z = ++instances * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        seed = (z ^ (z >> 31)) | 1;
+
+        k = accuracy;
+        levels.emplace_back();
+        updateCaps();
+    }
+
+    void add(double v) {
+        levels[0].push_back(v);
+        count++;
+        if (++stored >= totalCap) compress();
+    }
+
+    void merge(const QuantileSketch& other) {
+        while (levels.size() < other.levels.size()) levels.emplace_back();
+        for (size_t h = 0; h < other.levels.size(); h++)
+            levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+        count += other.count;
+        stored += other.stored;
+        updateCaps();
+        compress();
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // Value at rank q (0..1), same nearest-rank rule as the exact version
+    double quantile(double q) const {
+        if (count == 0)
+            throw runtime_error("No data for quantile");
+
+        vector<pair<double, uint64_t>> items;
+        uint64_t total = 0;
+        for (size_t h = 0; h < levels.size(); h++)
+            for (double v : levels[h]) {
+                items.push_back({v, 1ULL << h});
+                total += 1ULL << h;
+            }
+        sort(items.begin(), items.end());
+
+        double target = max(1.0, ceil(q * total));
+        uint64_t seen = 0;
+        for (const auto& it : items) {
+            seen += it.second;
+            if (seen >= target) return it.first;
+        }
+        return items.back().first;
+    }
+};
+
+// ======================== STATISTICS ========================
+// Top-K, exact quantiles and moving averages over the column snapshot.
+// type: 0 = all, 1 = Income, 2 = Expense
+class Statistics {
+public:
+    // Rows of the k largest amounts, largest first (bounded min-heap)
+    static vector<size_t> topK(const LedgerColumns& c, size_t k, int type) {
+        auto larger = [&](size_t a, size_t b) { return c.amount[a] > c.amount[b]; };
+        vector<size_t> heap;    // Min-heap on amount, at most k rows
+        if (k == 0) return heap;
+
+        for (size_t i = 0; i < c.size(); i++) {
+            if (type && c.type[i] != type) continue;
+            if (heap.size() < k) {
+                heap.push_back(i);
+                push_heap(heap.begin(), heap.end(), larger);
+            }
+            else if (c.amount[i] > c.amount[heap.front()]) {
+                pop_heap(heap.begin(), heap.end(), larger);
+                heap.back() = i;
+                push_heap(heap.begin(), heap.end(), larger);
+            }
+        }
+        sort_heap(heap.begin(), heap.end(), larger);
+        return heap;
+    }
+
+    // Exact nearest-rank quantiles (copies the amounts once)
+    static vector<double> exactQuantiles(const LedgerColumns& c, const vector<double>& qs, int type) {
+        vector<double> values;
+        for (size_t i = 0; i < c.size(); i++)
+            if (!type || c.type[i] == type) values.push_back(c.amount[i]);
+        if (values.empty())
+            throw runtime_error("No data for quantile");
+
+        vector<double> out;
+        for (double q : qs) {
+            size_t rank = (size_t)max(1.0, ceil(q * values.size())) - 1;
+            nth_element(values.begin(), values.begin() + rank, values.end());
+            out.push_back(values[rank]);
+        }
+        return out;
+    }
+
+    // Builds a sketch of the amounts, one partial sketch per thread
+    static QuantileSketch buildSketch(const LedgerColumns& c, int type) {
+        const size_t minPerWorker = 100000;
+        vector<QuantileSketch> parts(workerCount(c.size(), minPerWorker));
+
+        parallelFor(c.size(), [&](size_t begin, size_t end, size_t w) {
+            for (size_t i = begin; i < end; i++)
+                if (!type || c.type[i] == type) parts[w].add(c.amount[i]);
+        }, minPerWorker);
+
+        for (size_t w = 1; w < parts.size(); w++) parts[0].merge(parts[w]);
+        return parts[0];
+    }
+
+    // Trailing moving average of the daily total, one value per day
+    // from the first to the last dated transaction: (day, average)
+    static vector<pair<long long, double>> movingAverage(const LedgerColumns& c, int windowDays, int type) {
+        if (windowDays <= 0)
+            throw invalid_argument("Window must be greater than 0");
+
+        long long first = numeric_limits<long long>::max(), last = numeric_limits<long long>::min();
+        for (size_t i = 0; i < c.size(); i++) {
+            if (c.time[i] == LedgerColumns::NO_TIME || (type && c.type[i] != type)) continue;
+            long long day = c.time[i] / 86400 - (c.time[i] % 86400 < 0);
+            first = min(first, day);
+            last = max(last, day);
+        }
+
+        vector<pair<long long, double>> out;
+        if (first > last) return out;
+
+        // Daily totals, then one sliding sum across them
+        vector<double> daily((size_t)(last - first + 1), 0.0);
+        for (size_t i = 0; i < c.size(); i++) {
+            if (c.time[i] == LedgerColumns::NO_TIME || (type && c.type[i] != type)) continue;
+            long long day = c.time[i] / 86400 - (c.time[i] % 86400 < 0);
+            daily[day - first] += c.amount[i];
+        }
+
+        double sum = 0;
+        out.reserve(daily.size());
+        for (size_t d = 0; d < daily.size(); d++) {
+            sum += daily[d];
+            if (d >= (size_t)windowDays) sum -= daily[d - windowDays];
+            out.push_back({first + (long long)d, sum / windowDays});
+        }
+        return out;
+    }
+};
+
 // ======================== FINANCE MANAGER ========================
 // Handles all transactions + file operations
 class FinanceManager {
 private:
     vector<Transaction*> records;   // Stores pointers to all transactions
+    vector<RecurringRule> rules;    // Recurring Income / Expense rules
+    mutable LedgerColumns cols;     // Column snapshot for queries
+    mutable bool colsDirty = true;  // Snapshot must be rebuilt
+    mutable QuantileSketch sketches[2];     // Income / Expense amounts
+    mutable bool sketchesDirty = true;      // Sketches must be rebuilt
     string filename;                // CSV file name
+    string rulesFilename;           // CSV file for recurring rules
 
 public:
-    FinanceManager(string file = "transactions.csv") {
+    FinanceManager(string file = "transactions.csv", string ruleFile = "recurring.csv") {
         filename = file;
+        rulesFilename = ruleFile;
     }
 
     bool isEmpty() const {
@@ -101,7 +882,8 @@ public:
         return string(dt);
     }
 
-    // Calculates total balance = income - expense
+    // Calculates total balance = income - expense,
+    // including recurring rule occurrences up to yesterday
     double getBalance() {
         double income = 0, expense = 0;
         for (auto t : records) {
@@ -110,7 +892,19 @@ public:
             else
                 expense += t->getAmount();
         }
-        return income - expense;
+        return income - expense + getRuleBalance(todayDay());
+    }
+
+    // Net amount of all rule occurrences before the given day.
+    // Occurrences are counted on the fly, never stored as records.
+    double getRuleBalance(long long beforeDay) const {
+        double net = 0;
+        for (const RecurringRule& r : rules) {
+            long long n = 0;
+            r.forEachOccurrence(r.getStartDay(), beforeDay - 1, [&](long long) { n++; });
+            net += (r.getType() == "Income" ? 1 : -1) * r.getAmount() * n;
+        }
+        return net;
     }
 
     // Adds a transaction to vector + saves to file
@@ -119,6 +913,20 @@ public:
             throw invalid_argument("Amount must be greater than 0");
 
         records.push_back(t);
+        colsDirty = true;
+        noteAmount(t);
+        saveToFile();
+    }
+
+    // Adds many transactions at once, saving the file a single time
+    void addTransactions(const vector<Transaction*>& batch) {
+        for (Transaction* t : batch)
+            if (t->getAmount() <= 0)
+                throw invalid_argument("Amount must be greater than 0");
+
+        records.insert(records.end(), batch.begin(), batch.end());
+        colsDirty = true;
+        for (Transaction* t : batch) noteAmount(t);
         saveToFile();
     }
 
@@ -129,6 +937,8 @@ public:
 
         delete records[index];
         records.erase(records.begin() + index);
+        colsDirty = true;
+        sketchesDirty = true;   // Sketches cannot forget a value
         saveToFile();
     }
 
@@ -146,36 +956,67 @@ public:
         }
     }
 
-    // Writes all data to CSV file
-    void saveToFile() {
-        ofstream file(filename);
+    const vector<Transaction*>& getRecords() const {
+        return records;
+    }
 
-        for (int i = 0; i < records.size(); i++) {
-            file << records[i]->getType() << ","
-                 << records[i]->getAmount() << ","
-                 << records[i]->getDateTime() << ","
-                 << records[i]->getNote() << "\n";
+    // Keeps the quantile sketches current when a transaction is added
+    void noteAmount(const Transaction* t) {
+        if (!sketchesDirty)
+            sketches[t->getType() == "Income" ? 0 : 1].add(t->getAmount());
+    }
+
+    // Approximate quantile sketch (type: 0 = all, 1 = Income, 2 = Expense)
+    QuantileSketch sketch(int type) const {
+        if (sketchesDirty) {
+            sketches[0] = Statistics::buildSketch(columns(), 1);
+            sketches[1] = Statistics::buildSketch(columns(), 2);
+            sketchesDirty = false;
         }
+        if (type) return sketches[type - 1];
 
-        file.close();
+        QuantileSketch all = sketches[0];
+        all.merge(sketches[1]);
+        return all;
+    }
+
+    // Column snapshot of the records, rebuilt only after changes
+    const LedgerColumns& columns() const {
+        if (colsDirty) {
+            cols = LedgerColumns(records);
+            colsDirty = false;
+        }
+        return cols;
+    }
+
+    // Writes all data to CSV file (quoted CSV, no header row)
+    void saveToFile() {
+        vector<size_t> all(records.size());
+        iota(all.begin(), all.end(), 0);
+        Exporter(records).exportTo(filename, ExportFormat::CSV, all, false);
     }
 
     // Loads saved data from CSV file when program starts
     void loadFromFile() {
         records.clear();
+        colsDirty = true;
+        sketchesDirty = true;
         ifstream file(filename);
         if (!file.is_open()) return;
 
-        string type, amtStr, dt, nt;
+        vector<string> f;
         double amt;
 
-        // CSV reading using commas
-        while (getline(file, type, ',') &&
-               getline(file, amtStr, ',') &&
-               getline(file, dt, ',') &&
-               getline(file, nt))
-        {
-            amt = stod(amtStr);
+        // CSV reading (quoted fields allowed)
+        while (readCsvRecord(file, f)) {
+            if (f.size() < 4) continue;
+
+            // Older files did not quote notes: keep extra commas in the note
+            string type = f[0], dt = f[2], nt = f[3];
+            for (size_t i = 4; i < f.size(); i++)
+                nt += "," + f[i];
+
+            amt = stod(f[1]);
 
             if (type == "Income")
                 records.push_back(new Income(amt, dt, nt));
@@ -186,32 +1027,942 @@ public:
         file.close();
     }
 
-    // Destructor — to free dynamically allocated memory
-    ~FinanceManager() {
-        for (int i = 0; i < records.size(); i++)
-            delete records[i];
-    }
-};
+    // ----- Recurring rules -----
 
-// ======================== MAIN FUNCTION ========================
-int main() {
-    FinanceManager fm;
-    fm.loadFromFile();     // Load old data from file
+    const vector<RecurringRule>& getRules() const {
+        return rules;
+    }
 
-    int choice, n;
-    double amount;
+    // Adds a recurring rule + saves rules file
+    void addRule(const RecurringRule& r) {
+        rules.push_back(r);
+        saveRules();
+    }
 
-    while (true) {
+    // Deletes selected recurring rule
+    void removeRule(int index) {
+        if (index < 0 || index >= (int)rules.size())
+            throw out_of_range("Invalid index");
 
-        // Menu
-        cout << "\n1. Add Transactions"
-             << "\n2. Display Transactions"
-             << "\n3. Remove Transaction"
-             << "\n4. Check Balance"
-             << "\n5. Exit"
-             << "\nEnter choice: ";
+        rules.erase(rules.begin() + index);
+        saveRules();
+    }
 
-        cin >> choice;
+    // Displays all recurring rules in list form
+    void displayRules() const {
+        if (rules.empty()) {
+            cout << "\nNo recurring rules found.\n";
+            return;
+        }
+
+        cout << "\n--- Recurring Rules ---\n";
+        for (int i = 0; i < (int)rules.size(); i++) {
+            cout << i << ". ";
+            rules[i].display();
+        }
+    }
+
+    // Writes rules as: type,amount,period,start,end,note (end empty = open)
+    void saveRules() {
+        ofstream file(rulesFilename);
+
+        for (const RecurringRule& r : rules) {
+            string amt;
+            appendDouble(amt, r.getAmount());   // Full precision, unlike <<
+            file << r.getType() << ","
+                 << amt << ","
+                 << r.getPeriod() << ","
+                 << formatDay(r.getStartDay()) << ","
+                 << (r.getEndDay() == RecurringRule::NO_END ? "" : formatDay(r.getEndDay())) << ","
+                 << r.getNote() << "\n";
+        }
+
+        file.close();
+    }
+
+    // Loads recurring rules saved by saveRules().
+    // Malformed rows are skipped; returns how many were skipped.
+    int loadRules() {
+        rules.clear();
+        ifstream file(rulesFilename);
+        if (!file.is_open()) return 0;
+
+        int skipped = 0;
+        string type, amtStr, period, start, end, nt;
+
+        while (getline(file, type, ',') &&
+               getline(file, amtStr, ',') &&
+               getline(file, period, ',') &&
+               getline(file, start, ',') &&
+               getline(file, end, ',') &&
+               getline(file, nt))
+        {
+            try {
+                rules.push_back(RecurringRule(type, stod(amtStr), period, nt, parseDay(start),
+                                              end.empty() ? RecurringRule::NO_END : parseDay(end)));
+            }
+            catch (exception&) {
+                skipped++;
+            }
+        }
+
+        file.close();
+        return skipped;
+    }
+
+    // Destructor — to free dynamically allocated memory
+    ~FinanceManager() {
+        for (int i = 0; i < records.size(); i++)
+            delete records[i];
+    }
+};
+
+// ======================== CASH-FLOW PROJECTION ========================
+// Scales recurring income / expenses to answer "what if" questions
+struct Scenario {
+    double incomeFactor = 1.0;
+    double expenseFactor = 1.0;
+};
+
+// Summary of one projected balance curve
+struct ScenarioResult {
+    double finalBalance = 0;
+    double minBalance = 0;
+    long long minDay = 0;
+    long long firstNegativeDay = -1;    // -1 if the balance never goes below 0
+};
+
+// Projects the daily balance from the current balance plus all rules.
+// Rule occurrences are bucketed per day once and turned into prefix sums,
+// so every scenario is a single linear pass over two arrays.
+class CashFlowProjector {
+private:
+    long long firstDay;          // Day number of index 0 (today)
+    double opening;              // Balance before any projected flow
+    vector<double> cumIncome;    // Running total of projected income
+    vector<double> cumExpense;   // Running total of projected expenses
+
+public:
+    static const int MAX_YEARS = 100;
+
+    CashFlowProjector(double openingBalance, const vector<RecurringRule>& rules,
+                      long long fromDay, int years) {
+        if (years <= 0)
+            throw invalid_argument("Years must be greater than 0");
+        if (years > MAX_YEARS)
+            throw invalid_argument("Years must be at most " + to_string(MAX_YEARS));
+
+        firstDay = fromDay;
+        opening = openingBalance;
+
+        // Same calendar date N years later, clamped for 29 Feb
+        int y, m, d;
+        civilFromDays(fromDay, y, m, d);
+        long long lastDay = daysFromCivil(y + years, m, min(d, daysInMonth(y + years, m)));
+        size_t days = (size_t)(lastDay - fromDay + 1);
+
+        cumIncome.assign(days, 0.0);
+        cumExpense.assign(days, 0.0);
+
+        for (const RecurringRule& r : rules) {
+            vector<double>& flow = (r.getType() == "Income") ? cumIncome : cumExpense;
+            double amt = r.getAmount();
+            r.forEachOccurrence(fromDay, lastDay, [&](long long day) {
+                flow[day - fromDay] += amt;
+            });
+        }
+
+        inclusive_scan(cumIncome.begin(), cumIncome.end(), cumIncome.begin());
+        inclusive_scan(cumExpense.begin(), cumExpense.end(), cumExpense.begin());
+    }
+
+    long long getFirstDay() const {
+        return firstDay;
+    }
+    size_t getDays() const {
+        return cumIncome.size();
+    }
+
+    // Full projected balance curve, one value per day
+    vector<double> dailyBalance(const Scenario& s = Scenario()) const {
+        size_t n = cumIncome.size();
+        vector<double> out(n);
+        const double* inc = cumIncome.data();
+        const double* exp = cumExpense.data();
+        double fi = s.incomeFactor, fe = s.expenseFactor;
+        for (size_t i = 0; i < n; i++)
+            out[i] = opening + fi * inc[i] - fe * exp[i];
+        return out;
+    }
+
+    // Summarises one scenario without materialising the curve
+    ScenarioResult evaluate(const Scenario& s) const {
+        size_t n = cumIncome.size();
+        const double* inc = cumIncome.data();
+        const double* exp = cumExpense.data();
+        double fi = s.incomeFactor, fe = s.expenseFactor;
+
+        // One pass tracks the minimum, where it happens and the first negative day
+        ScenarioResult res;
+        size_t lowestAt = 0;
+        long long firstNegative = -1;
+        double lowest = opening + fi * inc[0] - fe * exp[0];
+        for (size_t i = 0; i < n; i++) {
+            double b = opening + fi * inc[i] - fe * exp[i];
+            if (b < lowest) {
+                lowest = b;
+                lowestAt = i;
+            }
+            if (firstNegative < 0 && b < 0)
+                firstNegative = (long long)i;
+        }
+
+        res.finalBalance = opening + fi * inc[n - 1] - fe * exp[n - 1];
+        res.minBalance = lowest;
+        res.minDay = firstDay + (long long)lowestAt;
+        res.firstNegativeDay = firstNegative < 0 ? -1 : firstDay + firstNegative;
+        return res;
+    }
+
+    // Evaluates many scenarios, split across hardware threads
+    vector<ScenarioResult> sweep(const vector<Scenario>& scenarios) const {
+        vector<ScenarioResult> results(scenarios.size());
+        parallelFor(scenarios.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++)
+                results[i] = evaluate(scenarios[i]);
+        }, 64);
+        return results;
+    }
+};
+
+// ======================== RECONCILIATION ========================
+// One row of an imported bank statement
+struct StatementRow {
+    string type;
+    double amount;
+    string dateTime;
+    string note;
+};
+
+// Outcome of reconciling a statement against the ledger
+struct ReconcileReport {
+    size_t matched = 0;
+    size_t skipped = 0;             // Malformed statement rows
+    vector<StatementRow> missing;   // In the statement, not in the ledger
+    vector<StatementRow> duplicates; // Unmatched exact repeats of an earlier timed row
+};
+
+// Matches statement rows to ledger rows with the same type, amount and
+// normalised note whose calendar days are at most `window` days apart
+// (bank statements often carry only a date).
+// The ledger is indexed once in a hash table of time-sorted buckets; each
+// statement row binary-searches its bucket and only looks at the entries
+// inside its window.
+class Reconciler {
+private:
+    struct Entry {
+        long long time;     // Seconds since 1970
+        long long day;      // Calendar day of time
+        bool used;          // Already claimed by a statement row
+    };
+
+    // (key, time) of a statement row, to spot exact repeats
+    struct Seen {
+        uint64_t key;
+        long long time;
+        bool operator==(const Seen& o) const {
+            return key == o.key && time == o.time;
+        }
+    };
+    struct SeenHash {
+        size_t operator()(const Seen& s) const {
+            return (size_t)(s.key ^ ((uint64_t)s.time * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+    unordered_map<uint64_t, vector<Entry>> index;
+    long long window;       // Allowed difference in calendar days
+
+    // Lower-case letters / digits only, single spaces, "No note" = empty
+    static void normalizeNote(const string& note, string& out) {
+        out.clear();
+        for (unsigned char c : note) {
+            if (isalnum(c)) out += (char)tolower(c);
+            else if (!out.empty() && out.back() != ' ') out += ' ';
+        }
+        if (!out.empty() && out.back() == ' ') out.pop_back();
+        if (out == "no note") out.clear();
+    }
+
+    // 64-bit FNV-1a over (type, amount in cents, normalised note).
+    // Collisions between different keys are negligible at ledger sizes.
+    static uint64_t keyOf(const string& type, double amount, const string& note) {
+        uint64_t h = 14695981039346656037ULL;
+        auto mix = [&](unsigned char c) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        };
+        mix(type == "Income" ? 1 : 2);
+        long long cents = llround(amount * 100);
+        for (int i = 0; i < 8; i++) mix((unsigned char)(cents >> (i * 8)));
+        thread_local string norm;
+        normalizeNote(note, norm);
+        for (char c : norm) mix((unsigned char)c);
+        return h;
+    }
+
+    static long long dayOf(long long time) {
+        return time / 86400 - (time % 86400 < 0);
+    }
+
+    // Claims the unused entry within the day window that is closest in
+    // time; false if none
+    bool claim(vector<Entry>& bucket, long long time) {
+        long long day = dayOf(time);
+        auto it = lower_bound(bucket.begin(), bucket.end(), day - window,
+                              [](const Entry& e, long long d) { return e.day < d; });
+        Entry* best = nullptr;
+        for (; it != bucket.end() && it->day <= day + window; ++it)
+            if (!it->used && (!best || llabs(best->time - time) > llabs(it->time - time)))
+                best = &*it;
+
+        if (!best) return false;
+        best->used = true;
+        return true;
+    }
+
+public:
+    Reconciler(const vector<Transaction*>& records, int windowDays = 2) {
+        if (windowDays < 0)
+            throw invalid_argument("Window must not be negative");
+        window = windowDays;
+
+        // Hashing + note normalisation is the expensive part: do it in parallel
+        size_t n = records.size();
+        vector<uint64_t> keys(n);
+        vector<long long> times(n);
+        parallelFor(n, [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                const Transaction* t = records[i];
+                keys[i] = keyOf(t->getType(), t->getAmount(), t->getNote());
+                if (!tryParseTimestamp(t->getDateTime(), times[i]))
+                    times[i] = numeric_limits<long long>::min() / 2;
+            }
+        }, 10000);
+
+        index.reserve(n);
+        for (size_t i = 0; i < n; i++)
+            index[keys[i]].push_back({times[i], dayOf(times[i]), false});
+        for (auto& bucket : index)
+            sort(bucket.second.begin(), bucket.second.end(),
+                 [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    }
+
+    // Streams a statement CSV (type,amount,dateTime,note; header optional)
+    ReconcileReport reconcile(const string& path) {
+        ifstream file(path);
+        if (!file.is_open())
+            throw runtime_error("Cannot open file: " + path);
+
+        ReconcileReport report;
+        unordered_set<Seen, SeenHash> seen;
+        vector<string> f;
+        bool first = true;
+
+        while (readCsvRecord(file, f)) {
+            if (first && !f.empty() && f[0] == "type") {
+                first = false;
+                continue;
+            }
+            first = false;
+
+            StatementRow row;
+            long long time;
+            if (f.size() < 3 || (f[0] != "Income" && f[0] != "Expense") ||
+                !tryParseTimestamp(f[2], time)) {
+                report.skipped++;
+                continue;
+            }
+            row.type = f[0];
+            row.dateTime = f[2];
+            row.note = (f.size() > 3 && !f[3].empty()) ? f[3] : "No note";
+            try {
+                row.amount = stod(f[1]);
+            }
+            catch (exception&) {
+                report.skipped++;
+                continue;
+            }
+            if (row.amount <= 0) {
+                report.skipped++;
+                continue;
+            }
+
+            // A row that matches the ledger is never a duplicate. Otherwise it
+            // is one only if it repeats an earlier row to the second; rows
+            // with just a date (midnight) can legitimately repeat.
+            uint64_t key = keyOf(row.type, row.amount, row.note);
+            bool hasClock = row.dateTime.find(':') != string::npos;
+            bool repeat = hasClock && !seen.insert({key, time}).second;
+
+            auto bucket = index.find(key);
+            if (bucket != index.end() && claim(bucket->second, time))
+                report.matched++;
+            else if (repeat)
+                report.duplicates.push_back(row);
+            else
+                report.missing.push_back(row);
+        }
+
+        file.close();
+        return report;
+    }
+};
+
+// ======================== QUERY LANGUAGE ========================
+// Filters such as:  type=Expense and amount>500 and date>=2026-01 and note~"rent"
+//
+//   fields    type, amount, date, note
+//   compare   =  !=  <  <=  >  >=   ~ (note contains, case-insensitive)
+//   combine   and, or, not, ( )
+//
+// A query is parsed once into a plan tree. Running it scans the column
+// snapshot in blocks of 4096 rows; every node produces a selection bitmap
+// for the block and AND / OR combine bitmaps word by word. Large scans
+// are spread over several threads.
+class Query {
+private:
+    enum Kind { AND, OR, NOT, TYPE, AMOUNT, TIME, NOTE_EQ, NOTE_HAS };
+    enum Op { EQ, NE, LT, LE, GT, GE, HAS };
+
+    struct Node {
+        Kind kind;
+        Op op = EQ;
+        double num = 0;             // AMOUNT value / TYPE code
+        long long lo = 0, hi = 0;   // TIME half-open range [lo, hi)
+        string text;                // NOTE value (lower-cased for ~)
+        string label;               // Text shown by EXPLAIN
+        vector<int> kids;
+        int cost = 1;               // Rough relative cost per row
+    };
+
+    // Per-node counters collected while explaining
+    struct Stats {
+        size_t rows = 0;
+        double ms = 0;
+    };
+
+    static const size_t BLOCK = 4096;           // Rows per block (64 words)
+    static const size_t PARALLEL_ROWS = 200000; // Minimum rows per scan thread
+
+    vector<Node> nodes;
+    int root = -1;
+    string source;
+
+    // Parser state
+    vector<string> tokens;
+    size_t pos = 0;
+
+    // ----- Parsing -----
+
+    static bool isOpChar(char c) {
+        return c == '=' || c == '!' || c == '<' || c == '>' || c == '~';
+    }
+
+    void tokenize(const string& text) {
+        size_t i = 0;
+        while (i < text.size()) {
+            char c = text[i];
+            if (isspace((unsigned char)c)) {
+                i++;
+            }
+            else if (c == '(' || c == ')') {
+                tokens.push_back(string(1, c));
+                i++;
+            }
+            else if (c == '"') {
+                size_t end = text.find('"', i + 1);
+                if (end == string::npos)
+                    throw invalid_argument("Unterminated string in query");
+                tokens.push_back(text.substr(i, end - i + 1));   // Keeps the quotes
+                i = end + 1;
+            }
+            else if (isOpChar(c)) {
+                size_t len = (i + 1 < text.size() && text[i + 1] == '=' && c != '=' && c != '~') ? 2 : 1;
+                tokens.push_back(text.substr(i, len));
+                i += len;
+            }
+            else {
+                size_t start = i;
+                while (i < text.size() && !isspace((unsigned char)text[i]) &&
+                       text[i] != '(' && text[i] != ')' && text[i] != '"' && !isOpChar(text[i]))
+                    i++;
+                tokens.push_back(text.substr(start, i - start));
+            }
+        }
+    }
+
+    static string lower(string s) {
+        for (char& c : s) c = (char)tolower((unsigned char)c);
+        return s;
+    }
+
+    bool peekWord(const string& w) const {
+        return pos < tokens.size() && lower(tokens[pos]) == w;
+    }
+
+    const string& next(const char* what) {
+        if (pos >= tokens.size())
+            throw invalid_argument(string("Query ended early, expected ") + what);
+        return tokens[pos++];
+    }
+
+    int add(Node n) {
+        nodes.push_back(n);
+        return (int)nodes.size() - 1;
+    }
+
+    int parseOr() {
+        int left = parseAnd();
+        if (!peekWord("or")) return left;
+
+        Node n;
+        n.kind = OR;
+        n.label = "OR";
+        n.kids.push_back(left);
+        while (peekWord("or")) {
+            pos++;
+            n.kids.push_back(parseAnd());
+        }
+        return add(n);
+    }
+
+    int parseAnd() {
+        int left = parseUnary();
+        if (!peekWord("and")) return left;
+
+        Node n;
+        n.kind = AND;
+        n.label = "AND";
+        n.kids.push_back(left);
+        while (peekWord("and")) {
+            pos++;
+            n.kids.push_back(parseUnary());
+        }
+        return add(n);
+    }
+
+    int parseUnary() {
+        if (peekWord("not")) {
+            pos++;
+            Node n;
+            n.kind = NOT;
+            n.label = "NOT";
+            n.kids.push_back(parseUnary());
+            return add(n);
+        }
+        if (pos < tokens.size() && tokens[pos] == "(") {
+            pos++;
+            int inner = parseOr();
+            if (next("')'") != ")")
+                throw invalid_argument("Expected ')' in query");
+            return inner;
+        }
+        return parseComparison();
+    }
+
+    // Turns a YYYY[-MM[-DD[ HH:MM[:SS]]]] literal into the range it covers
+    static void parseDateRange(const string& v, long long& lo, long long& hi) {
+        int y, m = 1, d = 1, h = 0, mi = 0, sec = 0;
+        int date = sscanf(v.c_str(), "%d-%d-%d", &y, &m, &d);
+        if (date < 1 || m < 1 || m > 12 || d < 1 || d > daysInMonth(y, m))
+            throw invalid_argument("Invalid date in query: " + v);
+
+        int clock = 0;
+        size_t space = v.find(' ');
+        if (date == 3 && space != string::npos)
+            clock = sscanf(v.c_str() + space + 1, "%d:%d:%d", &h, &mi, &sec);
+
+        lo = daysFromCivil(y, m, d) * 86400 + h * 3600 + mi * 60 + sec;
+        if (clock >= 2) hi = lo + (clock == 3 ? 1 : 60);
+        else if (date == 3) hi = lo + 86400;
+        else if (date == 2) hi = daysFromCivil(m == 12 ? y + 1 : y, m == 12 ? 1 : m + 1, 1) * 86400;
+        else hi = daysFromCivil(y + 1, 1, 1) * 86400;
+    }
+
+    int parseComparison() {
+        string field = lower(next("a field name"));
+        string opText = next("an operator");
+        string value = next("a value");
+        bool quoted = value.size() >= 2 && value.front() == '"';
+        if (quoted) value = value.substr(1, value.size() - 2);
+
+        Op op;
+        if (opText == "=") op = EQ;
+        else if (opText == "!=") op = NE;
+        else if (opText == "<") op = LT;
+        else if (opText == "<=") op = LE;
+        else if (opText == ">") op = GT;
+        else if (opText == ">=") op = GE;
+        else if (opText == "~") op = HAS;
+        else throw invalid_argument("Unknown operator in query: " + opText);
+
+        Node n;
+        n.op = op;
+        n.label = field + " " + opText + " " + (quoted ? "\"" + value + "\"" : value);
+
+        if (field == "type") {
+            string t = lower(value);
+            if ((op != EQ && op != NE) || (t != "income" && t != "expense"))
+                throw invalid_argument("type only supports = / != Income or Expense");
+            n.kind = TYPE;
+            n.num = (t == "income") ? 1 : 2;
+        }
+        else if (field == "amount") {
+            if (op == HAS)
+                throw invalid_argument("~ only works on note");
+            n.kind = AMOUNT;
+            try {
+                n.num = stod(value);
+            }
+            catch (exception&) {
+                throw invalid_argument("Invalid amount in query: " + value);
+            }
+        }
+        else if (field == "date") {
+            if (op == HAS)
+                throw invalid_argument("~ only works on note");
+            long long lo, hi;
+            parseDateRange(value, lo, hi);
+
+            // Every date comparison becomes a [lo, hi) time range
+            const long long MIN = LedgerColumns::NO_TIME + 1, MAX = numeric_limits<long long>::max();
+            n.kind = TIME;
+            n.lo = MIN;
+            n.hi = MAX;
+            if (op == EQ || op == NE) { n.lo = lo; n.hi = hi; }
+            else if (op == LT) n.hi = lo;
+            else if (op == LE) n.hi = hi;
+            else if (op == GT) n.lo = hi;
+            else n.lo = lo;
+
+            if (op == NE) {
+                // date != X  ==  NOT (date = X)
+                n.label = "date = " + value;
+                int inner = add(n);
+                Node neg;
+                neg.kind = NOT;
+                neg.label = "NOT";
+                neg.kids.push_back(inner);
+                return add(neg);
+            }
+        }
+        else if (field == "note") {
+            if (op != EQ && op != NE && op != HAS)
+                throw invalid_argument("note only supports =, != and ~");
+            n.kind = (op == HAS) ? NOTE_HAS : NOTE_EQ;
+            n.text = (op == HAS) ? lower(value) : value;
+            n.cost = (op == HAS) ? 8 : 4;
+        }
+        else {
+            throw invalid_argument("Unknown field in query: " + field);
+        }
+        return add(n);
+    }
+
+    // ----- Planning -----
+
+    // Flattens nested AND / OR and runs cheap children first
+    int plan(int id) {
+        Node& n = nodes[id];
+        if (n.kind != AND && n.kind != OR && n.kind != NOT) return nodes[id].cost;
+
+        vector<int> kids;
+        for (int k : nodes[id].kids) {
+            plan(k);
+            if (nodes[k].kind == nodes[id].kind && nodes[id].kind != NOT)
+                kids.insert(kids.end(), nodes[k].kids.begin(), nodes[k].kids.end());
+            else
+                kids.push_back(k);
+        }
+        stable_sort(kids.begin(), kids.end(), [&](int a, int b) {
+            return nodes[a].cost < nodes[b].cost;
+        });
+
+        int cost = 0;
+        for (int k : kids) cost += nodes[k].cost;
+        nodes[id].kids = kids;
+        nodes[id].cost = cost;
+        return cost;
+    }
+
+    // Time range implied by the top-level AND (the whole table if none)
+    void rootTimeRange(long long& lo, long long& hi) const {
+        lo = LedgerColumns::NO_TIME;
+        hi = numeric_limits<long long>::max();
+        vector<int> conj;
+        if (nodes[root].kind == AND) conj = nodes[root].kids;
+        else conj.push_back(root);
+        for (int k : conj)
+            if (nodes[k].kind == TIME) {
+                lo = max(lo, nodes[k].lo);
+                hi = min(hi, nodes[k].hi);
+            }
+    }
+
+    // ----- Execution -----
+
+    // Sets bit (i - begin) of out for every row i in [begin, end) where pred(i)
+    template <typename Pred>
+    static void scan(size_t begin, size_t end, uint64_t* out, Pred pred) {
+        for (size_t w = 0, r = begin; r < end; w++, r += 64) {
+            size_t stop = min(end, r + 64);
+            uint64_t bits = 0;
+            for (size_t i = r; i < stop; i++)
+                bits |= (uint64_t)pred(i) << (i - r);
+            out[w] = bits;
+        }
+    }
+
+    template <typename Cmp>
+    static void scanAmount(const LedgerColumns& c, size_t b, size_t e, uint64_t* out, double v, Cmp cmp) {
+        const double* a = c.amount.data();
+        scan(b, e, out, [&](size_t i) { return cmp(a[i], v); });
+    }
+
+    // Case-insensitive substring test (needle already lower-case)
+    static bool contains(const string& hay, const string& needle) {
+        size_t n = needle.size();
+        if (n > hay.size()) return false;
+        auto low = [](char x) { return (x >= 'A' && x <= 'Z') ? (char)(x | 0x20) : x; };
+        for (size_t i = 0; i + n <= hay.size(); i++) {
+            size_t j = 0;
+            while (j < n && low(hay[i + j]) == needle[j]) j++;
+            if (j == n) return true;
+        }
+        return false;
+    }
+
+    // Like scan(), but only tests rows whose bit is set in mask
+    template <typename Pred>
+    static void scanMasked(size_t begin, size_t end, const uint64_t* mask, uint64_t* out, Pred pred) {
+        for (size_t w = 0; w < (end - begin + 63) / 64; w++) {
+            uint64_t bits = 0;
+            for (uint64_t m = mask[w]; m; m &= m - 1) {
+                int bit = __builtin_ctzll(m);
+                bits |= (uint64_t)pred(begin + w * 64 + bit) << bit;
+            }
+            out[w] = bits;
+        }
+    }
+
+    // Evaluates node id over rows [b, e) (b is a multiple of 64, e - b <= BLOCK).
+    // Only rows set in mask (all rows if null) are decided; the others
+    // come back as 0. AND / OR pass down just the rows still undecided.
+    void eval(int id, const LedgerColumns& c, size_t b, size_t e, uint64_t* out,
+              Stats* stats, const uint64_t* mask = nullptr) const {
+        const Node& n = nodes[id];
+        size_t words = (e - b + 63) / 64;
+        auto started = chrono::steady_clock::now();
+
+        // Rows this call must decide, clipped to [b, e)
+        uint64_t scope[BLOCK / 64];
+        for (size_t w = 0; w < words; w++) scope[w] = mask ? mask[w] : ~0ULL;
+        if ((e - b) % 64) scope[words - 1] &= (1ULL << ((e - b) % 64)) - 1;
+
+        switch (n.kind) {
+        case TYPE: {
+            const uint8_t* t = c.type.data();
+            uint8_t code = (uint8_t)n.num;
+            if (n.op == EQ) scan(b, e, out, [&](size_t i) { return t[i] == code; });
+            else scan(b, e, out, [&](size_t i) { return t[i] != code; });
+            break;
+        }
+        case AMOUNT:
+            switch (n.op) {
+            case EQ: scanAmount(c, b, e, out, n.num, [](double a, double v) { return fabs(a - v) < 0.005; }); break;
+            case NE: scanAmount(c, b, e, out, n.num, [](double a, double v) { return fabs(a - v) >= 0.005; }); break;
+            case LT: scanAmount(c, b, e, out, n.num, [](double a, double v) { return a < v; }); break;
+            case LE: scanAmount(c, b, e, out, n.num, [](double a, double v) { return a <= v; }); break;
+            case GT: scanAmount(c, b, e, out, n.num, [](double a, double v) { return a > v; }); break;
+            default: scanAmount(c, b, e, out, n.num, [](double a, double v) { return a >= v; }); break;
+            }
+            break;
+        case TIME: {
+            const long long* t = c.time.data();
+            long long lo = n.lo, hi = n.hi;
+            scan(b, e, out, [&](size_t i) { return t[i] >= lo && t[i] < hi; });
+            break;
+        }
+        case NOTE_EQ:
+        case NOTE_HAS: {
+            // String tests are expensive: only look at rows still selected
+            auto test = [&](size_t i) {
+                if (n.kind == NOTE_HAS) return contains(*c.note[i], n.text);
+                return (*c.note[i] == n.text) == (n.op == EQ);
+            };
+            if (mask) scanMasked(b, e, mask, out, test);
+            else scan(b, e, out, test);
+            break;
+        }
+        case NOT: {
+            eval(n.kids[0], c, b, e, out, stats, scope);
+            for (size_t w = 0; w < words; w++) out[w] = ~out[w];
+            break;
+        }
+        case AND:
+        case OR: {
+            uint64_t tmp[BLOCK / 64], rest[BLOCK / 64];
+            eval(n.kids[0], c, b, e, out, stats, scope);
+            for (size_t k = 1; k < n.kids.size(); k++) {
+                // AND: rows still true; OR: rows still false (within scope)
+                uint64_t any = 0;
+                for (size_t w = 0; w < words; w++) {
+                    rest[w] = ((n.kind == AND) ? out[w] : ~out[w]) & scope[w];
+                    any |= rest[w];
+                }
+                if (!any) break;    // Block already decided
+
+                eval(n.kids[k], c, b, e, tmp, stats, rest);
+                for (size_t w = 0; w < words; w++)
+                    out[w] = (n.kind == AND) ? (out[w] & tmp[w]) : (out[w] | tmp[w]);
+            }
+            break;
+        }
+        }
+
+        for (size_t w = 0; w < words; w++) out[w] &= scope[w];
+
+        if (stats) {
+            for (size_t w = 0; w < words; w++) stats[id].rows += __builtin_popcountll(out[w]);
+            stats[id].ms += chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+        }
+    }
+
+    void explainNode(int id, int depth, const vector<Stats>& stats, ostringstream& out) const {
+        const Node& n = nodes[id];
+        out << string(depth * 2 + 2, ' ') << n.label
+            << "   [cost " << n.cost << ", rows " << stats[id].rows
+            << ", " << stats[id].ms << " ms]\n";
+        for (int k : n.kids) explainNode(k, depth + 1, stats, out);
+    }
+
+public:
+    // True if the text starts with the EXPLAIN keyword
+    static bool isExplain(const string& text) {
+        return lower(text.substr(0, 8)) == "explain ";
+    }
+
+    // Parses and plans the query; throws invalid_argument on syntax errors
+    explicit Query(const string& text) {
+        source = text;
+        tokenize(text);
+        if (tokens.empty())
+            throw invalid_argument("Empty query");
+        root = parseOr();
+        if (pos != tokens.size())
+            throw invalid_argument("Unexpected '" + tokens[pos] + "' in query");
+        plan(root);
+    }
+
+    // Returns the matching row indexes in ledger order.
+    // With explain set, fills it with the plan and per-node statistics.
+    vector<size_t> run(const LedgerColumns& c, string* explain = nullptr) const {
+        auto started = chrono::steady_clock::now();
+
+        // Use timestamp order as an index: narrow the scan to the rows in range
+        size_t begin = 0, end = c.size();
+        long long lo, hi;
+        rootTimeRange(lo, hi);
+        bool ranged = c.timeSorted && (lo != LedgerColumns::NO_TIME || hi != numeric_limits<long long>::max());
+        if (ranged) {
+            begin = c.lowerBound(lo);
+            end = max(begin, c.lowerBound(hi));
+        }
+
+        size_t first = begin / 64 * 64;
+        size_t blocks = (end - first + BLOCK - 1) / BLOCK;
+        vector<uint64_t> bitmap((c.size() + 63) / 64, 0);
+
+        const size_t minBlocks = PARALLEL_ROWS / BLOCK;
+        size_t workers = workerCount(blocks, minBlocks);
+        vector<vector<Stats>> stats(workers, vector<Stats>(explain ? nodes.size() : 0));
+
+        parallelFor(blocks, [&](size_t from, size_t to, size_t w) {
+            Stats* st = explain ? stats[w].data() : nullptr;
+            for (size_t k = from; k < to; k++) {
+                size_t b = first + k * BLOCK;
+                eval(root, c, b, min(end, b + BLOCK), &bitmap[b / 64], st);
+            }
+        }, minBlocks);
+
+        // Drop rows before begin that share the first word
+        if (begin > first && !bitmap.empty())
+            bitmap[first / 64] &= ~((1ULL << (begin - first)) - 1);
+
+        vector<size_t> rows;
+        for (size_t w = first / 64; w < (end + 63) / 64; w++)
+            for (uint64_t bits = bitmap[w]; bits; bits &= bits - 1)
+                rows.push_back(w * 64 + __builtin_ctzll(bits));
+
+        if (explain) {
+            vector<Stats> total(nodes.size());
+            for (const vector<Stats>& s : stats)
+                for (size_t i = 0; i < s.size(); i++) {
+                    total[i].rows += s[i].rows;
+                    total[i].ms += s[i].ms;
+                }
+
+            ostringstream out;
+            out << "Query: " << source << "\n";
+            if (ranged)
+                out << "Access: timestamp range scan, rows " << begin << ".." << end
+                    << " of " << c.size() << " (ledger is in time order)\n";
+            else
+                out << "Access: full scan of " << c.size() << " rows"
+                    << (c.timeSorted ? "" : " (ledger not in time order, date index unusable)") << "\n";
+            out << "Threads: " << workers << ", blocks: " << blocks << " x " << BLOCK << " rows\n"
+                << "Plan (children run cheapest first, rows = matches seen):\n";
+            explainNode(root, 0, total, out);
+            out << "Result: " << rows.size() << " rows in "
+                << chrono::duration<double, milli>(chrono::steady_clock::now() - started).count() << " ms\n";
+            *explain = out.str();
+        }
+        return rows;
+    }
+};
+
+// ======================== MAIN FUNCTION ========================
+int main() {
+    FinanceManager fm;
+    fm.loadFromFile();     // Load old data from file
+
+    // Rules live in their own file, whether or not transactions exist yet
+    int badRules = fm.loadRules();
+    if (badRules > 0)
+        cout << "Warning: skipped " << badRules
+             << " malformed recurring rule(s); they will be dropped on the next rule change.\n";
+
+    int choice, n;
+    double amount;
+
+    while (true) {
+
+        // Menu
+        cout << "\n1. Add Transactions"
+             << "\n2. Display Transactions"
+             << "\n3. Remove Transaction"
+             << "\n4. Check Balance"
+             << "\n5. Recurring Rules"
+             << "\n6. Project Balance"
+             << "\n7. Export Transactions"
+             << "\n8. Reconcile Bank Statement"
+             << "\n9. Query Transactions"
+             << "\n10. Statistics"
+             << "\n11. Exit"
+             << "\nEnter choice: ";
+
+        cin >> choice;
 
         if (cin.fail()) {
             cout << "Invalid input! Please enter a number.\n";
@@ -301,10 +2052,388 @@ int main() {
             // ===== OPTION 4: BALANCE =====
             else if (choice == 4) {
                 cout << "\nCurrent Balance = " << fm.getBalance() << endl;
+                if (!fm.getRules().empty())
+                    cout << "(includes " << fm.getRuleBalance(todayDay())
+                         << " from recurring rules up to yesterday)\n";
             }
 
-            // ===== OPTION 5: EXIT =====
+            // ===== OPTION 5: RECURRING RULES =====
             else if (choice == 5) {
+                fm.displayRules();
+                cout << "\n1. Add Rule\n2. Remove Rule\n3. Back\nEnter choice: ";
+                int sub;
+                cin >> sub;
+
+                if (cin.fail()) {
+                    cout << "Invalid input!\n";
+                    clearInput();
+                    continue;
+                }
+
+                if (sub == 1) {
+                    cout << "\n1. Income\n2. Expense\nEnter type: ";
+                    int t;
+                    cin >> t;
+                    cout << "Enter amount: ";
+                    cin >> amount;
+
+                    if (cin.fail()) {
+                        cout << "Invalid input!\n";
+                        clearInput();
+                        continue;
+                    }
+
+                    clearInput();
+                    string period, start, end, note;
+                    cout << "Enter period (daily/weekly/monthly/yearly): ";
+                    getline(cin, period);
+                    cout << "Enter start date (YYYY-MM-DD, empty = today): ";
+                    getline(cin, start);
+                    cout << "Enter end date (YYYY-MM-DD, empty = no end): ";
+                    getline(cin, end);
+                    cout << "Enter note: ";
+                    getline(cin, note);
+                    if (note == "") note = "No note";
+
+                    if (t != 1 && t != 2)
+                        throw invalid_argument("Invalid type!");
+
+                    fm.addRule(RecurringRule(t == 1 ? "Income" : "Expense", amount, period, note,
+                                             start.empty() ? todayDay() : parseDay(start),
+                                             end.empty() ? RecurringRule::NO_END : parseDay(end)));
+                    cout << "Rule added!\n";
+                }
+                else if (sub == 2) {
+                    cout << "Enter index to delete: ";
+                    cin >> n;
+
+                    if (cin.fail()) {
+                        cout << "Invalid input!\n";
+                        clearInput();
+                        continue;
+                    }
+
+                    fm.removeRule(n);
+                    cout << "Removed successfully!\n";
+                }
+            }
+
+            // ===== OPTION 6: PROJECTION =====
+            else if (choice == 6) {
+                cout << "Years to project: ";
+                cin >> n;
+
+                if (cin.fail()) {
+                    cout << "Invalid input!\n";
+                    clearInput();
+                    continue;
+                }
+
+                CashFlowProjector proj(fm.getBalance(), fm.getRules(), todayDay(), n);
+                ScenarioResult base = proj.evaluate(Scenario());
+
+                cout << "\nProjected balance on " << formatDay(proj.getFirstDay() + proj.getDays() - 1)
+                     << " = " << base.finalBalance
+                     << "\nLowest balance = " << base.minBalance << " on " << formatDay(base.minDay);
+                if (base.firstNegativeDay >= 0)
+                    cout << "\nBalance first goes negative on " << formatDay(base.firstNegativeDay);
+                cout << endl;
+
+                // Optional what-if sweep over income / expense multipliers
+                cout << "\nScenarios to sweep (0 to skip): ";
+                int count;
+                cin >> count;
+
+                if (cin.fail()) {
+                    cout << "Invalid input!\n";
+                    clearInput();
+                    continue;
+                }
+                if (count <= 0) continue;
+
+                // Grid of factors between 0.5x and 1.5x
+                int side = max(1, (int)ceil(sqrt((double)count)));
+                vector<Scenario> scenarios;
+                for (int i = 0; i < side && (int)scenarios.size() < count; i++)
+                    for (int j = 0; j < side && (int)scenarios.size() < count; j++) {
+                        Scenario sc;
+                        sc.incomeFactor = 0.5 + (side > 1 ? (double)i / (side - 1) : 0.5);
+                        sc.expenseFactor = 0.5 + (side > 1 ? (double)j / (side - 1) : 0.5);
+                        scenarios.push_back(sc);
+                    }
+
+                auto begin = chrono::steady_clock::now();
+                vector<ScenarioResult> results = proj.sweep(scenarios);
+                double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+                int negative = 0;
+                size_t worst = 0, best = 0;
+                for (size_t i = 0; i < results.size(); i++) {
+                    if (results[i].firstNegativeDay >= 0) negative++;
+                    if (results[i].minBalance < results[worst].minBalance) worst = i;
+                    if (results[i].finalBalance > results[best].finalBalance) best = i;
+                }
+
+                cout << "\n" << results.size() << " scenarios in " << ms << " ms"
+                     << "\nScenarios going negative: " << negative
+                     << "\nWorst (income x" << scenarios[worst].incomeFactor
+                     << ", expense x" << scenarios[worst].expenseFactor
+                     << "): lowest balance " << results[worst].minBalance
+                     << "\nBest (income x" << scenarios[best].incomeFactor
+                     << ", expense x" << scenarios[best].expenseFactor
+                     << "): final balance " << results[best].finalBalance << endl;
+            }
+
+            // ===== OPTION 7: EXPORT =====
+            else if (choice == 7) {
+                cout << "\n1. CSV\n2. JSON Lines\n3. Columnar (binary)\nEnter format: ";
+                int f;
+                cin >> f;
+                cout << "\n0. All\n1. Income\n2. Expense\nEnter type: ";
+                int t;
+                cin >> t;
+
+                if (cin.fail() || f < 1 || f > 3) {
+                    cout << "Invalid input!\n";
+                    clearInput();
+                    continue;
+                }
+
+                clearInput();
+                string path, from, to;
+                cout << "Enter file name: ";
+                getline(cin, path);
+                cout << "From date (YYYY-MM-DD, empty = any): ";
+                getline(cin, from);
+                cout << "To date (YYYY-MM-DD, empty = any): ";
+                getline(cin, to);
+
+                ExportFilter filter;
+                if (!from.empty()) filter.fromDay = parseDay(from);
+                if (!to.empty()) filter.toDay = parseDay(to);
+                if (t == 1) filter.type = "Income";
+                else if (t == 2) filter.type = "Expense";
+
+                Exporter ex(fm.getRecords());
+                ExportFormat fmt = (f == 1) ? ExportFormat::CSV
+                                 : (f == 2) ? ExportFormat::JSONL : ExportFormat::COLUMNAR;
+                size_t rows = ex.exportTo(path, fmt, ex.select(filter));
+                cout << "Exported " << rows << " rows to " << path << endl;
+            }
+
+            // ===== OPTION 8: RECONCILE =====
+            else if (choice == 8) {
+                cout << "Match window in days (0 = same calendar day): ";
+                int days;
+                cin >> days;
+
+                if (cin.fail()) {
+                    cout << "Invalid input!\n";
+                    clearInput();
+                    continue;
+                }
+
+                clearInput();
+                string path;
+                cout << "Enter statement file name: ";
+                getline(cin, path);
+
+                auto begin = chrono::steady_clock::now();
+                Reconciler rec(fm.getRecords(), days);
+                ReconcileReport report = rec.reconcile(path);
+                double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+                cout << "\nMatched: " << report.matched
+                     << "\nMissing: " << report.missing.size()
+                     << "\nDuplicates: " << report.duplicates.size()
+                     << "\nSkipped (malformed): " << report.skipped
+                     << "\nTime: " << ms << " ms\n";
+
+                // Show a few of each so the user can judge before importing
+                const size_t preview = 10;
+                for (size_t i = 0; i < report.missing.size() && i < preview; i++)
+                    cout << "  missing:   " << report.missing[i].type << " : " << report.missing[i].amount
+                         << "  |  " << report.missing[i].dateTime << "  |  Note: " << report.missing[i].note << endl;
+                for (size_t i = 0; i < report.duplicates.size() && i < preview; i++)
+                    cout << "  duplicate: " << report.duplicates[i].type << " : " << report.duplicates[i].amount
+                         << "  |  " << report.duplicates[i].dateTime << "  |  Note: " << report.duplicates[i].note << endl;
+
+                if (report.missing.empty()) continue;
+
+                cout << "Import " << report.missing.size() << " missing entries? (y/n): ";
+                string answer;
+                getline(cin, answer);
+                if (answer != "y" && answer != "Y") continue;
+
+                vector<Transaction*> batch;
+                for (const StatementRow& r : report.missing) {
+                    if (r.type == "Income")
+                        batch.push_back(new Income(r.amount, r.dateTime, r.note));
+                    else
+                        batch.push_back(new Expense(r.amount, r.dateTime, r.note));
+                }
+                fm.addTransactions(batch);
+                cout << "Imported " << batch.size() << " entries!\n";
+            }
+
+            // ===== OPTION 9: QUERY =====
+            else if (choice == 9) {
+                clearInput();
+                cout << "Enter query (prefix with EXPLAIN to see the plan)\n"
+                     << "e.g. type=Expense and amount>500 and date>=2026-01 and note~\"rent\"\n> ";
+                string text;
+                getline(cin, text);
+
+                bool explain = text.size() > 8 && Query::isExplain(text);
+                if (explain) text = text.substr(8);
+
+                Query q(text);
+                string plan;
+                vector<size_t> rows = q.run(fm.columns(), explain ? &plan : nullptr);
+                if (explain) cout << "\n" << plan;
+
+                // Listing (capped) + totals
+                const vector<Transaction*>& recs = fm.getRecords();
+                const size_t shown = 50;
+                double income = 0, expense = 0;
+                cout << "\n--- Matching Transactions ---\n";
+                for (size_t i = 0; i < rows.size(); i++) {
+                    const Transaction* t = recs[rows[i]];
+                    if (t->getType() == "Income") income += t->getAmount();
+                    else expense += t->getAmount();
+                    if (i < shown) {
+                        cout << rows[i] << ". ";
+                        t->display();
+                    }
+                }
+                if (rows.size() > shown)
+                    cout << "... " << rows.size() - shown << " more\n";
+
+                cout << "\nMatches: " << rows.size()
+                     << "\nIncome = " << income
+                     << "\nExpense = " << expense
+                     << "\nNet = " << income - expense << endl;
+
+                if (rows.empty()) continue;
+
+                cout << "\nExport results? 0. No  1. CSV  2. JSON Lines  3. Columnar: ";
+                int f;
+                cin >> f;
+
+                if (cin.fail()) {
+                    cout << "Invalid input!\n";
+                    clearInput();
+                    continue;
+                }
+                if (f < 1 || f > 3) continue;
+
+                clearInput();
+                string path;
+                cout << "Enter file name: ";
+                getline(cin, path);
+
+                ExportFormat fmt = (f == 1) ? ExportFormat::CSV
+                                 : (f == 2) ? ExportFormat::JSONL : ExportFormat::COLUMNAR;
+                cout << "Exported " << Exporter(recs).exportTo(path, fmt, rows)
+                     << " rows to " << path << endl;
+            }
+
+            // ===== OPTION 10: STATISTICS =====
+            else if (choice == 10) {
+                cout << "\n1. Largest Transactions (Top-K)"
+                     << "\n2. Median / p95"
+                     << "\n3. Moving Average"
+                     << "\nEnter choice: ";
+                int sub;
+                cin >> sub;
+                cout << "\n0. All\n1. Income\n2. Expense\nEnter type: ";
+                int t;
+                cin >> t;
+
+                if (cin.fail() || t < 0 || t > 2) {
+                    cout << "Invalid input!\n";
+                    clearInput();
+                    continue;
+                }
+
+                const LedgerColumns& cols = fm.columns();
+
+                if (sub == 1) {
+                    cout << "How many? ";
+                    cin >> n;
+
+                    if (cin.fail() || n < 0) {
+                        cout << "Invalid input!\n";
+                        clearInput();
+                        continue;
+                    }
+
+                    vector<size_t> rows = Statistics::topK(cols, n, t);
+                    cout << "\n--- Top " << rows.size() << " ---\n";
+                    for (size_t r : rows) {
+                        cout << r << ". ";
+                        fm.getRecords()[r]->display();
+                    }
+                }
+                else if (sub == 2) {
+                    cout << "\n1. Exact\n2. Approximate (sketch)\nEnter mode: ";
+                    int mode;
+                    cin >> mode;
+
+                    if (cin.fail()) {
+                        cout << "Invalid input!\n";
+                        clearInput();
+                        continue;
+                    }
+
+                    vector<double> qs = {0.5, 0.9, 0.95, 0.99};
+                    vector<double> vals;
+                    auto begin = chrono::steady_clock::now();
+                    if (mode == 1) {
+                        vals = Statistics::exactQuantiles(cols, qs, t);
+                    }
+                    else {
+                        QuantileSketch sk = fm.sketch(t);
+                        for (double q : qs) vals.push_back(sk.quantile(q));
+                    }
+                    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+                    cout << "\nMedian = " << vals[0]
+                         << "\np90 = " << vals[1]
+                         << "\np95 = " << vals[2]
+                         << "\np99 = " << vals[3]
+                         << "\n(" << (mode == 1 ? "exact" : "approximate") << ", " << ms << " ms)\n";
+                }
+                else if (sub == 3) {
+                    int window, shown;
+                    cout << "Window in days: ";
+                    cin >> window;
+                    cout << "Days to show (most recent): ";
+                    cin >> shown;
+
+                    if (cin.fail() || shown < 0) {
+                        cout << "Invalid input!\n";
+                        clearInput();
+                        continue;
+                    }
+
+                    vector<pair<long long, double>> avg = Statistics::movingAverage(cols, window, t);
+                    if (avg.empty()) {
+                        cout << "\nNo dated transactions found.\n";
+                        continue;
+                    }
+
+                    cout << "\n--- " << window << "-day moving average (per day) ---\n";
+                    for (size_t i = avg.size() - min(avg.size(), (size_t)shown); i < avg.size(); i++)
+                        cout << formatDay(avg[i].first) << " : " << avg[i].second << endl;
+                }
+                else {
+                    cout << "Invalid choice!\n";
+                }
+            }
+
+            // ===== OPTION 11: EXIT =====
+            else if (choice == 11) {
                 break;
             }
 